@@ -95,6 +95,160 @@ static SDL_Color _get_color(v8::Local<v8::Value> value)
 	return color;
 }
 
+// paint, the render arguments decoded once and reused per call
+
+enum
+{
+	TTF_PAINT_SOLID = 0,
+	TTF_PAINT_SHADED = 1,
+	TTF_PAINT_BLENDED = 2,
+	TTF_PAINT_BLENDED_WRAPPED = 3
+};
+
+// plain render arguments, copyable so queued jobs can snapshot a paint
+
+struct PaintStyle
+{
+	int m_mode;
+	SDL_Color m_fg;
+	SDL_Color m_bg;
+	::Uint32 m_wrap_length;
+	::Uint32 m_format; // SDL_PIXELFORMAT_UNKNOWN keeps the render format
+public:
+	PaintStyle() :
+		m_mode(TTF_PAINT_BLENDED),
+		m_wrap_length(0),
+		m_format(SDL_PIXELFORMAT_UNKNOWN)
+	{
+		m_fg.r = m_fg.g = m_fg.b = m_fg.a = 0xFF;
+		m_bg.r = m_bg.g = m_bg.b = m_bg.a = 0x00;
+	}
+	// { mode, fg, bg, wrapLength, format }, missing keys are left unchanged;
+	// throws and changes nothing when mode is not a TTF_PAINT_* value
+	bool Set(v8::Local<v8::Object> options)
+	{
+		v8::Local<v8::Value> mode = options->Get(NANX_SYMBOL("mode"));
+		if (!mode->IsUndefined())
+		{
+			int value = NANX_int(mode);
+			if (!mode->IsNumber() || value < TTF_PAINT_SOLID || value > TTF_PAINT_BLENDED_WRAPPED) { Nan::ThrowTypeError("invalid paint mode"); return false; }
+			m_mode = value;
+		}
+		v8::Local<v8::Value> fg = options->Get(NANX_SYMBOL("fg"));
+		if (!fg->IsUndefined()) { m_fg = _get_color(fg); }
+		v8::Local<v8::Value> bg = options->Get(NANX_SYMBOL("bg"));
+		if (!bg->IsUndefined()) { m_bg = _get_color(bg); }
+		v8::Local<v8::Value> wrap_length = options->Get(NANX_SYMBOL("wrapLength"));
+		if (!wrap_length->IsUndefined()) { m_wrap_length = NANX_Uint32(wrap_length); }
+		v8::Local<v8::Value> format = options->Get(NANX_SYMBOL("format"));
+		if (!format->IsUndefined()) { m_format = NANX_Uint32(format); }
+		return true;
+	}
+	// size of the surface Render produces; wrapped text breaks greedily at spaces and newlines,
+	// giving lines * line skip by the widest line capped at the wrap length; text is restored on return
+	int Size(TTF_Font* font, char* text, int* w, int* h) const
+	{
+		if (m_mode != TTF_PAINT_BLENDED_WRAPPED || m_wrap_length == 0) { return TTF_SizeUTF8(font, text, w, h); }
+		int wrap_length = (int) m_wrap_length;
+		int lines = 0, width = 0;
+		char* start = text;
+		for (;;)
+		{
+			char* end = start; while (*end && *end != '\n') { ++end; }
+			char* line = start;
+			char* fit = start; // end of the last word that fits
+			char* word = start;
+			while (word < end)
+			{
+				char* next = word;
+				while (next < end && *next == ' ') { ++next; }
+				while (next < end && *next != ' ') { ++next; }
+				int line_w = 0, line_h = 0;
+				char save = *next; *next = '\0';
+				int err = TTF_SizeUTF8(font, line, &line_w, &line_h);
+				*next = save;
+				if (err < 0) { return err; }
+				if (line_w > wrap_length && fit > line)
+				{
+					++lines;
+					line = fit; while (line < end && *line == ' ') { ++line; }
+					fit = line;
+					word = line;
+					continue;
+				}
+				if (line_w > width) { width = line_w; }
+				fit = next;
+				word = next;
+			}
+			++lines;
+			if (!*end) { break; }
+			start = end + 1;
+		}
+		*w = (width < wrap_length)?(width):(wrap_length);
+		*h = lines * TTF_FontLineSkip(font);
+		return 0;
+	}
+	// no script access, safe on a worker thread
+	SDL_Surface* Render(TTF_Font* font, const char* text) const
+	{
+		SDL_Surface* surface = NULL;
+		switch (m_mode)
+		{
+		case TTF_PAINT_SOLID: surface = TTF_RenderUTF8_Solid(font, text, m_fg); break;
+		case TTF_PAINT_SHADED: surface = TTF_RenderUTF8_Shaded(font, text, m_fg, m_bg); break;
+		case TTF_PAINT_BLENDED: surface = TTF_RenderUTF8_Blended(font, text, m_fg); break;
+		case TTF_PAINT_BLENDED_WRAPPED: surface = TTF_RenderUTF8_Blended_Wrapped(font, text, m_fg, m_wrap_length); break;
+		}
+		if (surface && m_format != SDL_PIXELFORMAT_UNKNOWN && surface->format->format != m_format)
+		{
+			SDL_Surface* converted = SDL_ConvertSurfaceFormat(surface, m_format, 0);
+			SDL_FreeSurface(surface);
+			surface = converted;
+		}
+		return surface;
+	}
+};
+
+class WrapPaint : public Nan::ObjectWrap
+{
+public:
+	Nan::Persistent<v8::Object> m_font_object; // keeps m_font_wrap alive
+	WrapFont* m_font_wrap; // locked per call, so TTF_CloseFont is safe
+	PaintStyle m_style;
+public:
+	WrapPaint(v8::Local<v8::Object> font_object) : m_font_wrap(WrapFont::Unwrap(font_object)) { m_font_object.Reset(font_object); }
+	~WrapPaint() { m_font_object.Reset(); m_font_wrap = NULL; }
+public:
+	bool Set(v8::Local<v8::Object> options) { return m_style.Set(options); }
+	v8::Local<v8::Object> GetFont() { return Nan::New<v8::Object>(m_font_object); }
+	SDL_Surface* Render(TTF_Font* font, const char* text) { return m_style.Render(font, text); }
+public:
+	static WrapPaint* Unwrap(v8::Local<v8::Value> value) { return (value->IsObject())?(Nan::ObjectWrap::Unwrap<WrapPaint>(v8::Local<v8::Object>::Cast(value))):(NULL); }
+	static v8::Local<v8::Object> NewInstance(v8::Local<v8::Object> font_object)
+	{
+		Nan::EscapableHandleScope scope;
+		v8::Local<v8::ObjectTemplate> object_template = GetObjectTemplate();
+		v8::Local<v8::Object> instance = object_template->NewInstance();
+		WrapPaint* wrap = new WrapPaint(font_object);
+		wrap->Wrap(instance);
+		return scope.Escape(instance);
+	}
+private:
+	static v8::Local<v8::ObjectTemplate> GetObjectTemplate()
+	{
+		Nan::EscapableHandleScope scope;
+		static Nan::Persistent<v8::ObjectTemplate> g_object_template;
+		if (g_object_template.IsEmpty())
+		{
+			v8::Local<v8::ObjectTemplate> object_template = Nan::New<v8::ObjectTemplate>();
+			g_object_template.Reset(object_template);
+			object_template->SetInternalFieldCount(1);
+		}
+		v8::Local<v8::ObjectTemplate> object_template = Nan::New<v8::ObjectTemplate>(g_object_template);
+		return scope.Escape(object_template);
+	}
+};
+
 // open font
 
 class Task_TTF_OpenFontIndex : public Nanx::SimpleTask
@@ -105,12 +259,14 @@ public:
 	int m_index;
 	Nan::Persistent<v8::Function> m_callback;
 	TTF_Font* m_font;
+	FontData* m_data;
 public:
 	Task_TTF_OpenFontIndex(v8::Local<v8::String> file, v8::Local<v8::Integer> ptsize, v8::Local<v8::Function> callback) :
 		m_file(strdup(*v8::String::Utf8Value(file))),
 		m_ptsize(NANX_int(ptsize)),
 		m_index(0),
-		m_font(NULL)
+		m_font(NULL),
+		m_data(NULL)
 	{
 		m_callback.Reset(callback);
 	}
@@ -118,7 +274,8 @@ public:
 		m_file(strdup(*v8::String::Utf8Value(file))),
 		m_ptsize(NANX_int(ptsize)),
 		m_index(NANX_int(index)),
-		m_font(NULL)
+		m_font(NULL),
+		m_data(NULL)
 	{
 		m_callback.Reset(callback);
 	}
@@ -126,21 +283,873 @@ public:
 	{
 		free(m_file); m_file = NULL; // strdup
 		m_callback.Reset();
-		if (m_font) { TTF_CloseFont(m_font); m_font = NULL; }
+		WrapFont::Free(m_font); m_font = NULL;
+		if (m_data) { m_data->Release(); m_data = NULL; }
 	}
 	void DoWork()
 	{
-		m_font = TTF_OpenFontIndex(m_file, m_ptsize, m_index);
+		// read the file outside the library lock so opens only serialize on face creation
+		FontData* data = FontData::Load(m_file); if (!data) { return; }
+		SDL_LockMutex(WrapFont::LibraryMutex());
+		m_font = TTF_OpenFontIndexRW(SDL_RWFromConstMem(data->Peek(), (int) data->Size()), 1, m_ptsize, m_index);
+		SDL_UnlockMutex(WrapFont::LibraryMutex());
+		if (m_font) { m_data = data; } else { data->Release(); }
 	}
 	void DoAfterWork(int status)
 	{
 		Nan::HandleScope scope;
-		v8::Local<v8::Value> argv[] = { WrapFont::Hold(m_font) };
+		v8::Local<v8::Value> argv[] = { WrapFont::Hold(m_font, m_data) };
+		m_data = NULL; // wrap holds reference
 		Nan::MakeCallback(Nan::GetCurrentContext()->Global(), Nan::New<v8::Function>(m_callback), countof(argv), argv);
 		m_font = NULL; // script owns pointer
 	}
 };
 
+// preload fonts
+
+static double _elapsed_ms(::Uint64 start)
+{
+	return (double) (SDL_GetPerformanceCounter() - start) * 1000.0 / (double) SDL_GetPerformanceFrequency();
+}
+
+class FontPreload
+{
+public:
+	struct Entry
+	{
+		char* m_file;
+		int m_ptsize;
+		int m_index;
+		int m_group; // first entry with the same file
+		TTF_Font* m_font;
+		FontData* m_data;
+		char* m_error;
+		double m_time; // milliseconds reading the file and opening the face
+		double m_wait; // milliseconds waiting for the library lock
+		bool m_aborted;
+	};
+private:
+	int m_refs;
+	SDL_atomic_t m_abort;
+public:
+	int m_count;
+	Entry* m_entries;
+	int m_pending; // file tasks not yet delivered
+	int m_done; // entries delivered
+	Nan::Persistent<v8::Function> m_progress;
+	Nan::Persistent<v8::Function> m_callback;
+	Nan::Persistent<v8::Array> m_results;
+public:
+	FontPreload(v8::Local<v8::Array> manifest, v8::Local<v8::Value> progress, v8::Local<v8::Function> callback) :
+		m_refs(1),
+		m_count(manifest->Length()),
+		m_entries(new Entry[manifest->Length()]),
+		m_pending(0),
+		m_done(0)
+	{
+		SDL_AtomicSet(&m_abort, 0);
+		for (int i = 0; i < m_count; ++i)
+		{
+			Entry* entry = &m_entries[i];
+			v8::Local<v8::Value> item = manifest->Get(i);
+			v8::Local<v8::Object> obj = item->IsObject() ? v8::Local<v8::Object>::Cast(item) : Nan::New<v8::Object>();
+			entry->m_file = strdup(*v8::String::Utf8Value(obj->Get(NANX_SYMBOL("file"))));
+			entry->m_ptsize = NANX_int(obj->Get(NANX_SYMBOL("ptsize")));
+			entry->m_index = NANX_int(obj->Get(NANX_SYMBOL("index")));
+			entry->m_group = i;
+			for (int j = 0; j < i; ++j)
+			{
+				if (strcmp(m_entries[j].m_file, entry->m_file) == 0) { entry->m_group = m_entries[j].m_group; break; }
+			}
+			if (entry->m_group == i) { ++m_pending; }
+			entry->m_font = NULL;
+			entry->m_data = NULL;
+			entry->m_error = NULL;
+			entry->m_time = 0.0;
+			entry->m_wait = 0.0;
+			entry->m_aborted = false;
+		}
+		if (progress->IsFunction()) { m_progress.Reset(v8::Local<v8::Function>::Cast(progress)); }
+		m_callback.Reset(callback);
+		m_results.Reset(Nan::New<v8::Array>(m_count));
+	}
+private:
+	~FontPreload()
+	{
+		for (int i = 0; i < m_count; ++i)
+		{
+			Entry* entry = &m_entries[i];
+			free(entry->m_file); entry->m_file = NULL; // strdup
+			free(entry->m_error); entry->m_error = NULL; // strdup
+			WrapFont::Free(entry->m_font); entry->m_font = NULL;
+			if (entry->m_data) { entry->m_data->Release(); entry->m_data = NULL; }
+		}
+		delete[] m_entries; m_entries = NULL;
+		m_progress.Reset();
+		m_callback.Reset();
+		m_results.Reset();
+	}
+public:
+	FontPreload* Hold() { ++m_refs; return this; } // main thread only
+	void Release() { if (--m_refs == 0) { delete this; } } // main thread only
+	bool IsAborted() { return SDL_AtomicGet(&m_abort) != 0; }
+	void Abort() { SDL_AtomicSet(&m_abort, 1); }
+public:
+	// worker thread: read the group's file once and open every size from the shared bytes
+	void LoadGroup(int group)
+	{
+		if (IsAborted()) { MarkGroupAborted(group); return; }
+		::Uint64 start = SDL_GetPerformanceCounter();
+		SDL_ClearError();
+		FontData* data = FontData::Load(m_entries[group].m_file);
+		char* load_error = (data)?(NULL):(strdup(TTF_GetError()));
+		double load_time = _elapsed_ms(start);
+		for (int i = group; i < m_count; ++i)
+		{
+			Entry* entry = &m_entries[i];
+			if (entry->m_group != group) { continue; }
+			if (IsAborted()) { entry->m_aborted = true; continue; }
+			if (!data) { entry->m_error = strdup(load_error); entry->m_time = load_time; continue; }
+			::Uint64 wait_start = SDL_GetPerformanceCounter();
+			SDL_LockMutex(WrapFont::LibraryMutex());
+			entry->m_wait = _elapsed_ms(wait_start);
+			::Uint64 open_start = SDL_GetPerformanceCounter();
+			SDL_ClearError();
+			SDL_RWops* rw = SDL_RWFromConstMem(data->Peek(), (int) data->Size());
+			entry->m_font = TTF_OpenFontIndexRW(rw, 1, entry->m_ptsize, entry->m_index);
+			if (!entry->m_font) { entry->m_error = strdup(TTF_GetError()); }
+			entry->m_time = load_time + _elapsed_ms(open_start);
+			SDL_UnlockMutex(WrapFont::LibraryMutex());
+			if (entry->m_font) { entry->m_data = data->Hold(); }
+		}
+		free(load_error); load_error = NULL; // strdup
+		if (data) { data->Release(); data = NULL; }
+	}
+	// main thread: hand the group's results to script
+	void DeliverGroup(int group)
+	{
+		Nan::HandleScope scope;
+		v8::Local<v8::Array> results = Nan::New<v8::Array>(m_results);
+		for (int i = group; i < m_count; ++i)
+		{
+			Entry* entry = &m_entries[i];
+			if (entry->m_group != group) { continue; }
+			if (IsAborted() && entry->m_font)
+			{
+				// aborted while opening; nobody will claim this font
+				WrapFont::Free(entry->m_font); entry->m_font = NULL;
+				entry->m_data->Release(); entry->m_data = NULL;
+				entry->m_aborted = true;
+			}
+			v8::Local<v8::Object> result = Nan::New<v8::Object>();
+			result->Set(NANX_SYMBOL("file"), NANX_STRING(entry->m_file));
+			result->Set(NANX_SYMBOL("ptsize"), Nan::New(entry->m_ptsize));
+			result->Set(NANX_SYMBOL("index"), Nan::New(entry->m_index));
+			if (entry->m_font)
+			{
+				result->Set(NANX_SYMBOL("font"), WrapFont::Hold(entry->m_font, entry->m_data));
+				entry->m_font = NULL; entry->m_data = NULL; // script owns pointer
+			}
+			else
+			{
+				result->Set(NANX_SYMBOL("font"), Nan::Null());
+			}
+			if (entry->m_error) { result->Set(NANX_SYMBOL("error"), NANX_STRING(entry->m_error)); }
+			else { result->Set(NANX_SYMBOL("error"), Nan::Null()); }
+			result->Set(NANX_SYMBOL("time"), Nan::New(entry->m_time));
+			result->Set(NANX_SYMBOL("wait"), Nan::New(entry->m_wait));
+			result->Set(NANX_SYMBOL("aborted"), Nan::New(entry->m_aborted));
+			results->Set(i, result);
+			++m_done;
+			if (!m_progress.IsEmpty())
+			{
+				v8::Local<v8::Value> argv[] = { result, Nan::New(m_done), Nan::New(m_count) };
+				Nan::MakeCallback(Nan::GetCurrentContext()->Global(), Nan::New<v8::Function>(m_progress), countof(argv), argv);
+			}
+		}
+		if (--m_pending == 0) { Finish(); }
+	}
+	void Finish()
+	{
+		Nan::HandleScope scope;
+		v8::Local<v8::Value> argv[] = { Nan::New<v8::Array>(m_results), Nan::New(IsAborted()) };
+		Nan::MakeCallback(Nan::GetCurrentContext()->Global(), Nan::New<v8::Function>(m_callback), countof(argv), argv);
+	}
+private:
+	void MarkGroupAborted(int group)
+	{
+		for (int i = group; i < m_count; ++i)
+		{
+			if (m_entries[i].m_group == group) { m_entries[i].m_aborted = true; }
+		}
+	}
+};
+
+// wrap FontPreload pointer, returned to script so a preload can be aborted
+
+class WrapFontPreload : public Nan::ObjectWrap
+{
+private:
+	FontPreload* m_preload;
+public:
+	WrapFontPreload(FontPreload* preload) : m_preload(preload->Hold()) {}
+	~WrapFontPreload() { m_preload->Release(); m_preload = NULL; }
+public:
+	FontPreload* Peek() { return m_preload; }
+public:
+	static WrapFontPreload* Unwrap(v8::Local<v8::Value> value) { return (value->IsObject())?(Nan::ObjectWrap::Unwrap<WrapFontPreload>(v8::Local<v8::Object>::Cast(value))):(NULL); }
+	static FontPreload* Peek(v8::Local<v8::Value> value) { WrapFontPreload* wrap = Unwrap(value); return (wrap)?(wrap->Peek()):(NULL); }
+	static v8::Local<v8::Object> NewInstance(FontPreload* preload)
+	{
+		Nan::EscapableHandleScope scope;
+		v8::Local<v8::ObjectTemplate> object_template = GetObjectTemplate();
+		v8::Local<v8::Object> instance = object_template->NewInstance();
+		WrapFontPreload* wrap = new WrapFontPreload(preload);
+		wrap->Wrap(instance);
+		return scope.Escape(instance);
+	}
+private:
+	static v8::Local<v8::ObjectTemplate> GetObjectTemplate()
+	{
+		Nan::EscapableHandleScope scope;
+		static Nan::Persistent<v8::ObjectTemplate> g_object_template;
+		if (g_object_template.IsEmpty())
+		{
+			v8::Local<v8::ObjectTemplate> object_template = Nan::New<v8::ObjectTemplate>();
+			g_object_template.Reset(object_template);
+			object_template->SetInternalFieldCount(1);
+		}
+		v8::Local<v8::ObjectTemplate> object_template = Nan::New<v8::ObjectTemplate>(g_object_template);
+		return scope.Escape(object_template);
+	}
+};
+
+class Task_TTF_PreloadFonts : public Nanx::SimpleTask
+{
+public:
+	FontPreload* m_preload;
+	int m_group;
+public:
+	Task_TTF_PreloadFonts(FontPreload* preload, int group) :
+		m_preload(preload->Hold()),
+		m_group(group)
+	{
+	}
+	~Task_TTF_PreloadFonts()
+	{
+		m_preload->Release(); m_preload = NULL;
+	}
+	void DoWork()
+	{
+		m_preload->LoadGroup(m_group);
+	}
+	void DoAfterWork(int status)
+	{
+		m_preload->DeliverGroup(m_group);
+	}
+};
+
+// text document, laid out once and rendered as fixed height tiles
+
+class TextDocument
+{
+public:
+	struct Tile
+	{
+		int m_index; // -1 when empty
+		::Uint32 m_stamp;
+		Nan::Persistent<v8::Object> m_surface;
+	};
+	struct Waiter // async request for a tile that is rendering
+	{
+		Waiter* m_next;
+		int m_index;
+		Nan::Persistent<v8::Function> m_callback;
+	};
+private:
+	int m_refs;
+	Waiter* m_waiters;
+public:
+	bool m_open;
+	Nan::Persistent<v8::Object> m_font_object; // locked per render, so TTF_CloseFont is safe
+	char* m_text;
+	SDL_Color m_fg;
+	int m_wrap_length;
+	int m_line_skip;
+	int m_line_count;
+	int m_line_alloc;
+	int* m_line_start;
+	int* m_line_length;
+	int m_line_max; // longest line in bytes
+	int m_width;
+	int m_tile_height;
+	int m_tile_count;
+	Tile* m_tiles;
+	::Uint32 m_stamp;
+public:
+	TextDocument(v8::Local<v8::Object> font_object, TTF_Font* font, v8::Local<v8::String> text, SDL_Color fg, int wrap_length, int tile_height, int tile_count) :
+		m_refs(1),
+		m_waiters(NULL),
+		m_open(true),
+		m_text(strdup(*v8::String::Utf8Value(text))),
+		m_fg(fg),
+		m_wrap_length(wrap_length),
+		m_line_skip(TTF_FontLineSkip(font)),
+		m_line_count(0),
+		m_line_alloc(0),
+		m_line_start(NULL),
+		m_line_length(NULL),
+		m_line_max(0),
+		m_width(0),
+		m_tile_height((tile_height > 0)?(tile_height):(256)),
+		m_tile_count((tile_count > 0)?(tile_count):(4)),
+		m_tiles(new Tile[(tile_count > 0)?(tile_count):(4)]),
+		m_stamp(0)
+	{
+		m_font_object.Reset(font_object);
+		for (int i = 0; i < m_tile_count; ++i) { m_tiles[i].m_index = -1; m_tiles[i].m_stamp = 0; }
+		Layout(font);
+	}
+private:
+	~TextDocument()
+	{
+		// may run from a weak callback, so leave uncollected tile surfaces to the collector
+		for (int i = 0; i < m_tile_count; ++i) { m_tiles[i].m_surface.Reset(); }
+		while (m_waiters) { Waiter* next = m_waiters->m_next; m_waiters->m_callback.Reset(); delete m_waiters; m_waiters = next; }
+		m_font_object.Reset();
+		delete[] m_tiles; m_tiles = NULL;
+		free(m_line_start); m_line_start = NULL;
+		free(m_line_length); m_line_length = NULL;
+		free(m_text); m_text = NULL; // strdup
+	}
+public:
+	TextDocument* Hold() { ++m_refs; return this; } // main thread only
+	void Release() { if (--m_refs == 0) { delete this; } } // main thread only
+	bool IsOpen() { return m_open; }
+	v8::Local<v8::Object> GetFont() { return Nan::New<v8::Object>(m_font_object); }
+	int GetHeight() { return m_line_count * m_line_skip; }
+	int GetTileCount() { return (GetHeight() + m_tile_height - 1) / m_tile_height; }
+	void Close()
+	{
+		for (int i = 0; i < m_tile_count; ++i) { Evict(&m_tiles[i]); }
+		m_open = false;
+		m_font_object.Reset(); // workers still rendering pin the font themselves
+	}
+public:
+	bool IsRendering(int index)
+	{
+		for (Waiter* waiter = m_waiters; waiter; waiter = waiter->m_next) { if (waiter->m_index == index) { return true; } }
+		return false;
+	}
+	// queue a callback for the tile, called in request order by Resolve
+	void Wait(int index, v8::Local<v8::Function> callback)
+	{
+		Waiter** link = &m_waiters; while (*link) { link = &(*link)->m_next; }
+		Waiter* waiter = new Waiter();
+		waiter->m_next = NULL;
+		waiter->m_index = index;
+		waiter->m_callback.Reset(callback);
+		*link = waiter;
+	}
+	void Resolve(int index, v8::Local<v8::Value> surface)
+	{
+		Nan::HandleScope scope;
+		// detach first, a callback may request the tile again
+		Waiter* resolved = NULL; Waiter** tail = &resolved;
+		for (Waiter** link = &m_waiters; *link; )
+		{
+			Waiter* waiter = *link;
+			if (waiter->m_index == index) { *link = waiter->m_next; waiter->m_next = NULL; *tail = waiter; tail = &waiter->m_next; }
+			else { link = &waiter->m_next; }
+		}
+		while (resolved)
+		{
+			Waiter* waiter = resolved; resolved = waiter->m_next;
+			v8::Local<v8::Value> argv[] = { surface };
+			Nan::MakeCallback(Nan::GetCurrentContext()->Global(), Nan::New<v8::Function>(waiter->m_callback), countof(argv), argv);
+			waiter->m_callback.Reset();
+			delete waiter;
+		}
+	}
+	// returns the cached surface object for the tile, or an empty handle
+	v8::Local<v8::Object> Find(int index)
+	{
+		Nan::EscapableHandleScope scope;
+		for (int i = 0; i < m_tile_count; ++i)
+		{
+			Tile* tile = &m_tiles[i];
+			if (tile->m_index == index)
+			{
+				tile->m_stamp = ++m_stamp;
+				return scope.Escape(Nan::New<v8::Object>(tile->m_surface));
+			}
+		}
+		return v8::Local<v8::Object>();
+	}
+	// takes ownership of surface, evicting the least recently used tile
+	v8::Local<v8::Value> Insert(int index, SDL_Surface* surface)
+	{
+		Nan::EscapableHandleScope scope;
+		if (!surface) { return scope.Escape(Nan::Null()); }
+		Tile* lru = &m_tiles[0];
+		for (int i = 1; i < m_tile_count; ++i)
+		{
+			if (m_tiles[i].m_stamp < lru->m_stamp) { lru = &m_tiles[i]; }
+		}
+		Evict(lru);
+		v8::Local<v8::Object> object = v8::Local<v8::Object>::Cast(node_sdl2::WrapSurface::Hold(surface));
+		lru->m_index = index;
+		lru->m_stamp = ++m_stamp;
+		lru->m_surface.Reset(object);
+		return scope.Escape(object);
+	}
+	// rasterize only the lines that intersect the tile; the caller holds the font lock
+	SDL_Surface* Render(TTF_Font* font, int index)
+	{
+		if (index < 0 || index >= GetTileCount() || m_width <= 0) { return NULL; }
+		SDL_Surface* surface = SDL_CreateRGBSurface(0, m_width, m_tile_height, 32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000);
+		if (!surface) { return NULL; }
+		SDL_FillRect(surface, NULL, 0);
+		int top = index * m_tile_height;
+		int first = top / m_line_skip;
+		int last = (top + m_tile_height + m_line_skip - 1) / m_line_skip;
+		if (last > m_line_count) { last = m_line_count; }
+		char* line = (char*) malloc(m_line_max + 1);
+		for (int i = first; i < last; ++i)
+		{
+			if (m_line_length[i] == 0) { continue; }
+			memcpy(line, m_text + m_line_start[i], m_line_length[i]); line[m_line_length[i]] = '\0';
+			SDL_Surface* line_surface = TTF_RenderUTF8_Blended(font, line, m_fg);
+			if (!line_surface) { continue; }
+			SDL_SetSurfaceBlendMode(line_surface, SDL_BLENDMODE_NONE);
+			SDL_Rect dst = { 0, i * m_line_skip - top, line_surface->w, line_surface->h };
+			SDL_BlitSurface(line_surface, NULL, surface, &dst);
+			SDL_FreeSurface(line_surface);
+		}
+		free(line);
+		return surface;
+	}
+private:
+	void Evict(Tile* tile)
+	{
+		if (!tile->m_surface.IsEmpty())
+		{
+			// free now rather than at collection so the cache bounds memory
+			Nan::HandleScope scope;
+			SDL_Surface* surface = node_sdl2::WrapSurface::Drop(Nan::New<v8::Object>(tile->m_surface));
+			if (surface) { SDL_FreeSurface(surface); }
+			tile->m_surface.Reset();
+		}
+		tile->m_index = -1;
+		tile->m_stamp = 0;
+	}
+	void AddLine(TTF_Font* font, int start, int length)
+	{
+		if (m_line_count == m_line_alloc)
+		{
+			m_line_alloc = (m_line_alloc)?(m_line_alloc * 2):(64);
+			m_line_start = (int*) realloc(m_line_start, m_line_alloc * sizeof(int));
+			m_line_length = (int*) realloc(m_line_length, m_line_alloc * sizeof(int));
+		}
+		m_line_start[m_line_count] = start;
+		m_line_length[m_line_count] = length;
+		++m_line_count;
+		if (length > m_line_max) { m_line_max = length; }
+		int w = 0, h = 0;
+		if (length > 0)
+		{
+			char save = m_text[start + length]; m_text[start + length] = '\0';
+			TTF_SizeUTF8(font, m_text + start, &w, &h);
+			m_text[start + length] = save;
+		}
+		if (w > m_width) { m_width = w; }
+	}
+	// greedy word wrap at spaces, hard breaks at newlines
+	void Layout(TTF_Font* font)
+	{
+		int length = (int) strlen(m_text);
+		int start = 0;
+		while (start <= length)
+		{
+			int end = start;
+			while (end < length && m_text[end] != '\n') { ++end; }
+			if (m_wrap_length <= 0)
+			{
+				AddLine(font, start, end - start);
+			}
+			else
+			{
+				int line = start;
+				int fit = start; // end of the last word that fits
+				int word = start;
+				while (word < end)
+				{
+					int next = word;
+					while (next < end && m_text[next] == ' ') { ++next; }
+					while (next < end && m_text[next] != ' ') { ++next; }
+					int w = 0, h = 0;
+					char save = m_text[next]; m_text[next] = '\0';
+					TTF_SizeUTF8(font, m_text + line, &w, &h);
+					m_text[next] = save;
+					if (w > m_wrap_length && fit > line)
+					{
+						AddLine(font, line, fit - line);
+						line = fit; while (line < end && m_text[line] == ' ') { ++line; }
+						fit = line;
+						word = line;
+						continue;
+					}
+					fit = next;
+					word = next;
+				}
+				AddLine(font, line, fit - line);
+			}
+			start = end + 1;
+		}
+	}
+};
+
+// wrap TextDocument pointer
+
+class WrapTextDocument : public Nan::ObjectWrap
+{
+private:
+	TextDocument* m_document;
+public:
+	WrapTextDocument(TextDocument* document) : m_document(document->Hold()) {}
+	~WrapTextDocument() { m_document->Release(); m_document = NULL; }
+public:
+	TextDocument* Peek() { return m_document; }
+public:
+	static WrapTextDocument* Unwrap(v8::Local<v8::Value> value) { return (value->IsObject())?(Nan::ObjectWrap::Unwrap<WrapTextDocument>(v8::Local<v8::Object>::Cast(value))):(NULL); }
+	static TextDocument* Peek(v8::Local<v8::Value> value) { WrapTextDocument* wrap = Unwrap(value); return (wrap)?(wrap->Peek()):(NULL); }
+	static v8::Local<v8::Object> NewInstance(TextDocument* document)
+	{
+		Nan::EscapableHandleScope scope;
+		v8::Local<v8::ObjectTemplate> object_template = GetObjectTemplate();
+		v8::Local<v8::Object> instance = object_template->NewInstance();
+		WrapTextDocument* wrap = new WrapTextDocument(document);
+		wrap->Wrap(instance);
+		return scope.Escape(instance);
+	}
+private:
+	static v8::Local<v8::ObjectTemplate> GetObjectTemplate()
+	{
+		Nan::EscapableHandleScope scope;
+		static Nan::Persistent<v8::ObjectTemplate> g_object_template;
+		if (g_object_template.IsEmpty())
+		{
+			v8::Local<v8::ObjectTemplate> object_template = Nan::New<v8::ObjectTemplate>();
+			g_object_template.Reset(object_template);
+			object_template->SetInternalFieldCount(1);
+		}
+		v8::Local<v8::ObjectTemplate> object_template = Nan::New<v8::ObjectTemplate>(g_object_template);
+		return scope.Escape(object_template);
+	}
+};
+
+class Task_TTF_RenderDocumentTile : public Nanx::SimpleTask
+{
+public:
+	TextDocument* m_document;
+	int m_index;
+	WrapFontUse m_font; // acquired by the export
+	SDL_Surface* m_surface;
+public:
+	Task_TTF_RenderDocumentTile(TextDocument* document, int index) :
+		m_document(document->Hold()),
+		m_index(index),
+		m_surface(NULL)
+	{
+		m_font.Reset(document->GetFont());
+	}
+	~Task_TTF_RenderDocumentTile()
+	{
+		if (m_surface) { SDL_FreeSurface(m_surface); m_surface = NULL; }
+		m_document->Release(); m_document = NULL;
+	}
+	void DoWork()
+	{
+		m_font.Lock();
+		m_surface = m_document->Render(m_font.Peek(), m_index);
+		m_font.Unlock();
+	}
+	void DoAfterWork(int status)
+	{
+		Nan::HandleScope scope;
+		m_font.Release();
+		v8::Local<v8::Value> surface = Nan::Null();
+		if (m_document->IsOpen())
+		{
+			v8::Local<v8::Object> cached = m_document->Find(m_index);
+			if (!cached.IsEmpty()) { surface = cached; } // a sync render won the race
+			else { surface = m_document->Insert(m_index, m_surface); m_surface = NULL; }
+		}
+		m_document->Resolve(m_index, surface);
+	}
+};
+
+// render queue, prioritized and coalesced by key, delivered within a per-frame budget
+
+struct RenderJob
+{
+	RenderJob* m_next;
+	char* m_key;
+	int m_priority; // higher first
+	::Uint64 m_queued;
+	char* m_text;
+	WrapFontUse m_font; // acquired at dispatch
+	PaintStyle m_style;
+	SDL_Surface* m_surface;
+	char* m_error; // captured on the worker when m_surface is NULL
+	bool m_canceled; // superseded or canceled while rendering
+public:
+	RenderJob(v8::Local<v8::String> key, WrapPaint* paint, v8::Local<v8::String> text, int priority) :
+		m_next(NULL),
+		m_key(strdup(*v8::String::Utf8Value(key))),
+		m_priority(priority),
+		m_queued(SDL_GetPerformanceCounter()),
+		m_text(strdup(*v8::String::Utf8Value(text))),
+		m_style(paint->m_style),
+		m_surface(NULL),
+		m_error(NULL),
+		m_canceled(false)
+	{
+		m_font.Reset(paint->GetFont());
+	}
+	~RenderJob()
+	{
+		free(m_key); m_key = NULL; // strdup
+		free(m_text); m_text = NULL; // strdup
+		free(m_error); m_error = NULL; // strdup
+		if (m_surface) { SDL_FreeSurface(m_surface); m_surface = NULL; }
+	}
+};
+
+class RenderQueue
+{
+private:
+	int m_refs;
+	bool m_closed;
+public:
+	int m_workers; // max jobs rendering at once
+	RenderJob* m_pending;
+	RenderJob** m_running; // m_workers slots
+	RenderJob* m_completed;
+	int m_pending_count;
+	int m_running_count;
+	int m_completed_count;
+	int m_delivered_count;
+	double m_latency_total; // milliseconds, queued to delivered
+	double m_latency_max;
+	double m_latency_last;
+public:
+	RenderQueue(int workers) :
+		m_refs(1),
+		m_closed(false),
+		m_workers((workers > 0)?(workers):(2)),
+		m_pending(NULL),
+		m_running(new RenderJob*[(workers > 0)?(workers):(2)]),
+		m_completed(NULL),
+		m_pending_count(0),
+		m_running_count(0),
+		m_completed_count(0),
+		m_delivered_count(0),
+		m_latency_total(0),
+		m_latency_max(0),
+		m_latency_last(0)
+	{
+		for (int i = 0; i < m_workers; ++i) { m_running[i] = NULL; }
+	}
+private:
+	~RenderQueue()
+	{
+		FreeList(m_pending); m_pending = NULL;
+		FreeList(m_completed); m_completed = NULL;
+		delete[] m_running; m_running = NULL; // running jobs are owned by their tasks
+	}
+public:
+	RenderQueue* Hold() { ++m_refs; return this; } // main thread only
+	void Release() { if (--m_refs == 0) { delete this; } } // main thread only
+	bool IsClosed() { return m_closed; }
+	// drop pending and undelivered jobs and stop dispatching; running jobs finish and are discarded
+	void Close()
+	{
+		m_closed = true;
+		FreeList(m_pending); m_pending = NULL; m_pending_count = 0;
+		FreeList(m_completed); m_completed = NULL; m_completed_count = 0;
+		for (int i = 0; i < m_workers; ++i) { if (m_running[i]) { m_running[i]->m_canceled = true; } }
+	}
+public:
+	// a newer job for the same key replaces any pending, running or undelivered one
+	void Push(RenderJob* job)
+	{
+		Cancel(job->m_key);
+		job->m_next = m_pending; m_pending = job;
+		++m_pending_count;
+		Dispatch();
+	}
+	int Cancel(const char* key)
+	{
+		int count = 0;
+		count += Remove(&m_pending, key, &m_pending_count);
+		count += Remove(&m_completed, key, &m_completed_count);
+		for (int i = 0; i < m_workers; ++i)
+		{
+			RenderJob* job = m_running[i];
+			if (job && !job->m_canceled && strcmp(job->m_key, key) == 0) { job->m_canceled = true; ++count; }
+		}
+		return count;
+	}
+	void Dispatch();
+	void Complete(RenderJob* job)
+	{
+		for (int i = 0; i < m_workers; ++i) { if (m_running[i] == job) { m_running[i] = NULL; } }
+		--m_running_count;
+		job->m_font.Release();
+		if (job->m_canceled) { delete job; }
+		else { PushCompleted(job); }
+		Dispatch();
+	}
+	// highest priority completed job, oldest first among equals
+	RenderJob* PopCompleted() { return Pop(&m_completed, &m_completed_count, false); }
+	void PushCompleted(RenderJob* job) { job->m_next = m_completed; m_completed = job; ++m_completed_count; }
+private:
+	bool IsFontRunning(TTF_Font* font)
+	{
+		for (int i = 0; i < m_workers; ++i) { if (m_running[i] && m_running[i]->m_font.Peek() == font) { return true; } }
+		return false;
+	}
+	RenderJob* Pop(RenderJob** list, int* count, bool dispatch)
+	{
+		RenderJob** best = NULL;
+		for (RenderJob** link = list; *link; link = &(*link)->m_next)
+		{
+			RenderJob* job = *link;
+			if (dispatch)
+			{
+				// the font lock serializes renders anyway; don't park a second worker on it
+				TTF_Font* font = job->m_font.Current();
+				if (font && IsFontRunning(font)) { continue; }
+			}
+			if (!best || job->m_priority > (*best)->m_priority || (job->m_priority == (*best)->m_priority && job->m_queued <= (*best)->m_queued)) { best = link; }
+		}
+		if (!best) { return NULL; }
+		RenderJob* job = *best; *best = job->m_next; job->m_next = NULL;
+		--(*count);
+		return job;
+	}
+	static int Remove(RenderJob** list, const char* key, int* count)
+	{
+		int removed = 0;
+		for (RenderJob** link = list; *link; )
+		{
+			RenderJob* job = *link;
+			if (strcmp(job->m_key, key) == 0) { *link = job->m_next; delete job; --(*count); ++removed; }
+			else { link = &job->m_next; }
+		}
+		return removed;
+	}
+	static void FreeList(RenderJob* list)
+	{
+		while (list) { RenderJob* next = list->m_next; delete list; list = next; }
+	}
+};
+
+class Task_TTF_RenderQueueJob : public Nanx::SimpleTask
+{
+public:
+	RenderQueue* m_queue;
+	RenderJob* m_job;
+public:
+	Task_TTF_RenderQueueJob(RenderQueue* queue, RenderJob* job) :
+		m_queue(queue->Hold()),
+		m_job(job)
+	{
+	}
+	~Task_TTF_RenderQueueJob()
+	{
+		m_queue->Release(); m_queue = NULL;
+	}
+	void DoWork()
+	{
+		m_job->m_font.Lock();
+		SDL_ClearError();
+		m_job->m_surface = m_job->m_style.Render(m_job->m_font.Peek(), m_job->m_text);
+		if (!m_job->m_surface)
+		{
+			const char* error = TTF_GetError();
+			m_job->m_error = strdup((error && *error)?(error):("render failed"));
+		}
+		m_job->m_font.Unlock();
+	}
+	void DoAfterWork(int status)
+	{
+		Nan::HandleScope scope;
+		m_queue->Complete(m_job); m_job = NULL; // queue owns job
+	}
+};
+
+void RenderQueue::Dispatch()
+{
+	if (m_closed) { return; }
+	Nan::HandleScope scope;
+	while (m_running_count < m_workers)
+	{
+		RenderJob* job = Pop(&m_pending, &m_pending_count, true);
+		if (!job) { break; }
+		if (!job->m_font.Acquire())
+		{
+			// font was closed, report it instead of dropping the key
+			job->m_error = strdup("null font");
+			PushCompleted(job);
+			continue;
+		}
+		for (int i = 0; i < m_workers; ++i) { if (!m_running[i]) { m_running[i] = job; break; } }
+		++m_running_count;
+		Nanx::SimpleTask::Run(new Task_TTF_RenderQueueJob(this, job));
+	}
+}
+
+// wrap RenderQueue pointer
+
+class WrapRenderQueue : public Nan::ObjectWrap
+{
+private:
+	RenderQueue* m_queue;
+public:
+	WrapRenderQueue(RenderQueue* queue) : m_queue(queue->Hold()) {}
+	~WrapRenderQueue() { m_queue->Close(); m_queue->Release(); m_queue = NULL; } // nobody is left to deliver to
+public:
+	RenderQueue* Peek() { return m_queue; }
+public:
+	static WrapRenderQueue* Unwrap(v8::Local<v8::Value> value) { return (value->IsObject())?(Nan::ObjectWrap::Unwrap<WrapRenderQueue>(v8::Local<v8::Object>::Cast(value))):(NULL); }
+	static RenderQueue* Peek(v8::Local<v8::Value> value) { WrapRenderQueue* wrap = Unwrap(value); return (wrap)?(wrap->Peek()):(NULL); }
+	static v8::Local<v8::Object> NewInstance(RenderQueue* queue)
+	{
+		Nan::EscapableHandleScope scope;
+		v8::Local<v8::ObjectTemplate> object_template = GetObjectTemplate();
+		v8::Local<v8::Object> instance = object_template->NewInstance();
+		WrapRenderQueue* wrap = new WrapRenderQueue(queue);
+		wrap->Wrap(instance);
+		return scope.Escape(instance);
+	}
+private:
+	static v8::Local<v8::ObjectTemplate> GetObjectTemplate()
+	{
+		Nan::EscapableHandleScope scope;
+		static Nan::Persistent<v8::ObjectTemplate> g_object_template;
+		if (g_object_template.IsEmpty())
+		{
+			v8::Local<v8::ObjectTemplate> object_template = Nan::New<v8::ObjectTemplate>();
+			g_object_template.Reset(object_template);
+			object_template->SetInternalFieldCount(1);
+		}
+		v8::Local<v8::ObjectTemplate> object_template = Nan::New<v8::ObjectTemplate>(g_object_template);
+		return scope.Escape(object_template);
+	}
+};
+
 NANX_EXPORT(TTF_LinkedVersion) { Nan::ThrowError("TODO"); }
 
 NANX_EXPORT(TTF_ByteSwappedUNICODE)
@@ -200,26 +1209,55 @@ NANX_EXPORT(TTF_OpenFontIndex)
 	info.GetReturnValue().Set(Nan::New(err));
 }
 
+// TTF_PreloadFontsTask([ { file, ptsize, index }, ... ], progress(result, done, total), callback(results, aborted))
+NANX_EXPORT(TTF_PreloadFontsTask)
+{
+	if (!info[0]->IsArray()) { return Nan::ThrowTypeError("manifest must be an array"); }
+	v8::Local<v8::Array> manifest = v8::Local<v8::Array>::Cast(info[0]);
+	v8::Local<v8::Function> callback = v8::Local<v8::Function>::Cast(info[2]);
+	FontPreload* preload = new FontPreload(manifest, info[1], callback);
+	v8::Local<v8::Object> handle = WrapFontPreload::NewInstance(preload);
+	if (preload->m_pending == 0)
+	{
+		preload->Finish();
+	}
+	for (int i = 0; i < preload->m_count; ++i)
+	{
+		if (preload->m_entries[i].m_group == i)
+		{
+			Nanx::SimpleTask::Run(new Task_TTF_PreloadFonts(preload, i));
+		}
+	}
+	preload->Release(); // handle and tasks hold references
+	info.GetReturnValue().Set(handle);
+}
+
+NANX_EXPORT(TTF_AbortPreload)
+{
+	FontPreload* preload = WrapFontPreload::Peek(info[0]); if (!preload) { return Nan::ThrowError("null object"); }
+	preload->Abort();
+}
+
 NANX_EXPORT(TTF_OpenFontRW) { Nan::ThrowError("TODO"); }
 
 NANX_EXPORT(TTF_OpenFontIndexRW) { Nan::ThrowError("TODO"); }
 
 NANX_EXPORT(TTF_CloseFont)
 {
-	TTF_Font* font = WrapFont::Drop(info[0]); if (!font) { return Nan::ThrowError("null object"); }
-	TTF_CloseFont(font);
+	WrapFont* wrap = WrapFont::Unwrap(info[0]); if (!wrap || !wrap->Peek()) { return Nan::ThrowError("null object"); }
+	wrap->Close();
 }
 
 NANX_EXPORT(TTF_GetFontStyle)
 {
-	TTF_Font* font = WrapFont::Peek(info[0]); if (!font) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
 	int style = TTF_GetFontStyle(font);
 	info.GetReturnValue().Set(Nan::New(style));
 }
 
 NANX_EXPORT(TTF_SetFontStyle)
 {
-	TTF_Font* font = WrapFont::Peek(info[0]); if (!font) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
 	int style = NANX_int(info[1]);
 	TTF_SetFontStyle(font, style);
 	info.GetReturnValue().Set(Nan::New(style));
@@ -227,14 +1265,14 @@ NANX_EXPORT(TTF_SetFontStyle)
 
 NANX_EXPORT(TTF_GetFontOutline)
 {
-	TTF_Font* font = WrapFont::Peek(info[0]); if (!font) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
 	int outline = TTF_GetFontOutline(font);
 	info.GetReturnValue().Set(Nan::New(outline));
 }
 
 NANX_EXPORT(TTF_SetFontOutline)
 {
-	TTF_Font* font = WrapFont::Peek(info[0]); if (!font) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
 	int outline = NANX_int(info[1]);
 	TTF_SetFontOutline(font, outline);
 	info.GetReturnValue().Set(Nan::New(outline));
@@ -242,14 +1280,14 @@ NANX_EXPORT(TTF_SetFontOutline)
 
 NANX_EXPORT(TTF_GetFontHinting)
 {
-	TTF_Font* font = WrapFont::Peek(info[0]); if (!font) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
 	int hinting = TTF_GetFontHinting(font);
 	info.GetReturnValue().Set(Nan::New(hinting));
 }
 
 NANX_EXPORT(TTF_SetFontHinting)
 {
-	TTF_Font* font = WrapFont::Peek(info[0]); if (!font) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
 	int hinting = NANX_int(info[1]);
 	TTF_SetFontHinting(font, hinting);
 	info.GetReturnValue().Set(Nan::New(hinting));
@@ -257,42 +1295,42 @@ NANX_EXPORT(TTF_SetFontHinting)
 
 NANX_EXPORT(TTF_FontHeight)
 {
-	TTF_Font* font = WrapFont::Peek(info[0]); if (!font) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
 	int height = TTF_FontHeight(font);
 	info.GetReturnValue().Set(Nan::New(height));
 }
 
 NANX_EXPORT(TTF_FontAscent)
 {
-	TTF_Font* font = WrapFont::Peek(info[0]); if (!font) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
 	int ascent = TTF_FontAscent(font);
 	info.GetReturnValue().Set(Nan::New(ascent));
 }
 
 NANX_EXPORT(TTF_FontDescent)
 {
-	TTF_Font* font = WrapFont::Peek(info[0]); if (!font) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
 	int descent = TTF_FontDescent(font);
 	info.GetReturnValue().Set(Nan::New(descent));
 }
 
 NANX_EXPORT(TTF_FontLineSkip)
 {
-	TTF_Font* font = WrapFont::Peek(info[0]); if (!font) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
 	int line_skip = TTF_FontLineSkip(font);
 	info.GetReturnValue().Set(Nan::New(line_skip));
 }
 
 NANX_EXPORT(TTF_GetFontKerning)
 {
-	TTF_Font* font = WrapFont::Peek(info[0]); if (!font) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
 	int kerning = TTF_GetFontKerning(font);
 	info.GetReturnValue().Set(Nan::New(kerning));
 }
 
 NANX_EXPORT(TTF_SetFontKerning)
 {
-	TTF_Font* font = WrapFont::Peek(info[0]); if (!font) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
 	int kerning = NANX_int(info[1]);
 	TTF_SetFontKerning(font, kerning);
 	info.GetReturnValue().Set(Nan::New(kerning));
@@ -300,35 +1338,35 @@ NANX_EXPORT(TTF_SetFontKerning)
 
 NANX_EXPORT(TTF_FontFaces)
 {
-	TTF_Font* font = WrapFont::Peek(info[0]); if (!font) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
 	long faces = TTF_FontFaces(font);
 	info.GetReturnValue().Set(Nan::New((int32_t) faces)); // TODO: long
 }
 
 NANX_EXPORT(TTF_FontFaceIsFixedWidth)
 {
-	TTF_Font* font = WrapFont::Peek(info[0]); if (!font) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
 	int fixed_width = TTF_FontFaceIsFixedWidth(font);
 	info.GetReturnValue().Set(Nan::New(fixed_width));
 }
 
 NANX_EXPORT(TTF_FontFaceFamilyName)
 {
-	TTF_Font* font = WrapFont::Peek(info[0]); if (!font) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
 	char* name = TTF_FontFaceFamilyName(font);
 	info.GetReturnValue().Set(NANX_STRING(name));
 }
 
 NANX_EXPORT(TTF_FontFaceStyleName)
 {
-	TTF_Font* font = WrapFont::Peek(info[0]); if (!font) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
 	char* name = TTF_FontFaceStyleName(font);
 	info.GetReturnValue().Set(NANX_STRING(name));
 }
 
 NANX_EXPORT(TTF_GlyphIsProvided)
 {
-	TTF_Font* font = WrapFont::Peek(info[0]); if (!font) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
 	::Uint16 ch = NANX_Uint16(info[1]);
 	int provided = TTF_GlyphIsProvided(font, ch);
 	info.GetReturnValue().Set(Nan::New(provided));
@@ -336,7 +1374,7 @@ NANX_EXPORT(TTF_GlyphIsProvided)
 
 NANX_EXPORT(TTF_GlyphMetrics)
 {
-	TTF_Font* font = WrapFont::Peek(info[0]); if (!font) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
 	::Uint16 ch = NANX_Uint16(info[1]);
 	int minx = 0, maxx = 0;
 	int miny = 0, maxy = 0;
@@ -356,7 +1394,7 @@ NANX_EXPORT(TTF_GlyphMetrics)
 
 NANX_EXPORT(TTF_SizeText)
 {
-	TTF_Font* font = WrapFont::Peek(info[0]); if (!font) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
 	v8::Local<v8::String> text = v8::Local<v8::String>::Cast(info[1]);
 	int w = 0, h = 0;
 	int err = TTF_SizeText(font, *v8::String::Utf8Value(text), &w, &h);
@@ -371,7 +1409,7 @@ NANX_EXPORT(TTF_SizeText)
 
 NANX_EXPORT(TTF_SizeUTF8)
 {
-	TTF_Font* font = WrapFont::Peek(info[0]); if (!font) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
 	v8::Local<v8::String> text = v8::Local<v8::String>::Cast(info[1]);
 	int w = 0, h = 0;
 	int err = TTF_SizeUTF8(font, *v8::String::Utf8Value(text), &w, &h);
@@ -388,7 +1426,7 @@ NANX_EXPORT(TTF_SizeUNICODE) { Nan::ThrowError("TODO"); }
 
 NANX_EXPORT(TTF_RenderText_Solid)
 {
-	TTF_Font* font = WrapFont::Peek(info[0]); if (!font) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
 	v8::Local<v8::String> text = v8::Local<v8::String>::Cast(info[1]);
 	SDL_Color fg = _get_color(info[2]);
 	SDL_Surface* surface = TTF_RenderText_Solid(font, *v8::String::Utf8Value(text), fg);
@@ -397,7 +1435,7 @@ NANX_EXPORT(TTF_RenderText_Solid)
 
 NANX_EXPORT(TTF_RenderUTF8_Solid)
 {
-	TTF_Font* font = WrapFont::Peek(info[0]); if (!font) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
 	v8::Local<v8::String> text = v8::Local<v8::String>::Cast(info[1]);
 	SDL_Color fg = _get_color(info[2]);
 	SDL_Surface* surface = TTF_RenderText_Solid(font, *v8::String::Utf8Value(text), fg);
@@ -408,7 +1446,7 @@ NANX_EXPORT(TTF_RenderUNICODE_Solid) { Nan::ThrowError("TODO"); }
 
 NANX_EXPORT(TTF_RenderGlyph_Solid)
 {
-	TTF_Font* font = WrapFont::Peek(info[0]); if (!font) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
 	::Uint16 ch = NANX_Uint16(info[1]);
 	SDL_Color fg = _get_color(info[2]);
 	SDL_Surface* surface = TTF_RenderGlyph_Solid(font, ch, fg);
@@ -417,7 +1455,7 @@ NANX_EXPORT(TTF_RenderGlyph_Solid)
 
 NANX_EXPORT(TTF_RenderText_Shaded)
 {
-	TTF_Font* font = WrapFont::Peek(info[0]); if (!font) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
 	v8::Local<v8::String> text = v8::Local<v8::String>::Cast(info[1]);
 	SDL_Color fg = _get_color(info[2]);
 	SDL_Color bg = _get_color(info[3]);
@@ -427,7 +1465,7 @@ NANX_EXPORT(TTF_RenderText_Shaded)
 
 NANX_EXPORT(TTF_RenderUTF8_Shaded)
 {
-	TTF_Font* font = WrapFont::Peek(info[0]); if (!font) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
 	v8::Local<v8::String> text = v8::Local<v8::String>::Cast(info[1]);
 	SDL_Color fg = _get_color(info[2]);
 	SDL_Color bg = _get_color(info[3]);
@@ -439,7 +1477,7 @@ NANX_EXPORT(TTF_RenderUNICODE_Shaded) { Nan::ThrowError("TODO"); }
 
 NANX_EXPORT(TTF_RenderGlyph_Shaded)
 {
-	TTF_Font* font = WrapFont::Peek(info[0]); if (!font) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
 	::Uint16 ch = NANX_Uint16(info[1]);
 	SDL_Color fg = _get_color(info[2]);
 	SDL_Color bg = _get_color(info[3]);
@@ -450,7 +1488,7 @@ NANX_EXPORT(TTF_RenderGlyph_Shaded)
 // extern DECLSPEC SDL_Surface * SDLCALL TTF_RenderText_Blended(TTF_Font *font, const char *text, SDL_Color fg);
 NANX_EXPORT(TTF_RenderText_Blended)
 {
-	TTF_Font* font = WrapFont::Peek(info[0]); if (!font) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
 	v8::Local<v8::String> text = v8::Local<v8::String>::Cast(info[1]);
 	SDL_Color fg = _get_color(info[2]);
 	SDL_Surface* surface = TTF_RenderUTF8_Blended(font, *v8::String::Utf8Value(text), fg);
@@ -460,7 +1498,7 @@ NANX_EXPORT(TTF_RenderText_Blended)
 // extern DECLSPEC SDL_Surface * SDLCALL TTF_RenderUTF8_Blended(TTF_Font *font, const char *text, SDL_Color fg);
 NANX_EXPORT(TTF_RenderUTF8_Blended)
 {
-	TTF_Font* font = WrapFont::Peek(info[0]); if (!font) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
 	v8::Local<v8::String> text = v8::Local<v8::String>::Cast(info[1]);
 	SDL_Color fg = _get_color(info[2]);
 	SDL_Surface* surface = TTF_RenderUTF8_Blended(font, *v8::String::Utf8Value(text), fg);
@@ -471,7 +1509,7 @@ NANX_EXPORT(TTF_RenderUNICODE_Blended) { Nan::ThrowError("TODO"); }
 
 NANX_EXPORT(TTF_RenderGlyph_Blended)
 {
-	TTF_Font* font = WrapFont::Peek(info[0]); if (!font) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
 	::Uint16 ch = NANX_Uint16(info[1]);
 	SDL_Color fg = _get_color(info[2]);
 	SDL_Surface* surface = TTF_RenderGlyph_Blended(font, ch, fg);
@@ -487,7 +1525,7 @@ NANX_EXPORT(TTF_RenderGlyph_Blended)
 
 NANX_EXPORT(TTF_RenderText_Blended_Wrapped)
 {
-	TTF_Font* font = WrapFont::Peek(info[0]); if (!font) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
 	v8::Local<v8::String> text = v8::Local<v8::String>::Cast(info[1]);
 	SDL_Color fg = _get_color(info[2]);
 	::Uint32 wrapLength = NANX_Uint32(info[3]);
@@ -497,7 +1535,7 @@ NANX_EXPORT(TTF_RenderText_Blended_Wrapped)
 
 NANX_EXPORT(TTF_RenderUTF8_Blended_Wrapped)
 {
-	TTF_Font* font = WrapFont::Peek(info[0]); if (!font) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
 	v8::Local<v8::String> text = v8::Local<v8::String>::Cast(info[1]);
 	SDL_Color fg = _get_color(info[2]);
 	::Uint32 wrapLength = NANX_Uint32(info[3]);
@@ -509,7 +1547,7 @@ NANX_EXPORT(TTF_RenderUNICODE_Blended_Wrapped) { Nan::ThrowError("TODO"); }
 
 NANX_EXPORT(TTF_RenderText)
 {
-	TTF_Font* font = WrapFont::Peek(info[0]); if (!font) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
 	v8::Local<v8::String> text = v8::Local<v8::String>::Cast(info[1]);
 	SDL_Color fg = _get_color(info[2]);
 	SDL_Color bg = _get_color(info[3]);
@@ -519,7 +1557,7 @@ NANX_EXPORT(TTF_RenderText)
 
 NANX_EXPORT(TTF_RenderUTF8)
 {
-	TTF_Font* font = WrapFont::Peek(info[0]); if (!font) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
 	v8::Local<v8::String> text = v8::Local<v8::String>::Cast(info[1]);
 	SDL_Color fg = _get_color(info[2]);
 	SDL_Color bg = _get_color(info[3]);
@@ -529,9 +1567,215 @@ NANX_EXPORT(TTF_RenderUTF8)
 
 NANX_EXPORT(TTF_RenderUNICODE) { Nan::ThrowError("TODO"); }
 
+// TTF_CreatePaint(font, { mode, fg, bg, wrapLength, format })
+NANX_EXPORT(TTF_CreatePaint)
+{
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
+	v8::Local<v8::Object> paint = WrapPaint::NewInstance(v8::Local<v8::Object>::Cast(info[0]));
+	if (info[1]->IsObject() && !WrapPaint::Unwrap(paint)->Set(v8::Local<v8::Object>::Cast(info[1]))) { return; }
+	info.GetReturnValue().Set(paint);
+}
+
+NANX_EXPORT(TTF_SetPaint)
+{
+	WrapPaint* paint = WrapPaint::Unwrap(info[0]); if (!paint) { return Nan::ThrowError("null object"); }
+	if (info[1]->IsObject()) { paint->Set(v8::Local<v8::Object>::Cast(info[1])); }
+}
+
+NANX_EXPORT(TTF_RenderPaint)
+{
+	WrapPaint* paint = WrapPaint::Unwrap(info[0]); if (!paint) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(paint->m_font_wrap); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
+	v8::Local<v8::String> text = v8::Local<v8::String>::Cast(info[1]);
+	SDL_Surface* surface = paint->Render(font, *v8::String::Utf8Value(text));
+	if (surface == NULL)
+	{
+		info.GetReturnValue().SetNull();
+	}
+	else
+	{
+		info.GetReturnValue().Set(node_sdl2::WrapSurface::Hold(surface));
+	}
+}
+
+NANX_EXPORT(TTF_SizePaint)
+{
+	WrapPaint* paint = WrapPaint::Unwrap(info[0]); if (!paint) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(paint->m_font_wrap); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
+	v8::Local<v8::String> text = v8::Local<v8::String>::Cast(info[1]);
+	int w = 0, h = 0;
+	int err = paint->m_style.Size(font, *v8::String::Utf8Value(text), &w, &h);
+	if (info[2]->IsObject())
+	{
+		v8::Local<v8::Object> ret = v8::Local<v8::Object>::Cast(info[2]);
+		ret->Set(NANX_SYMBOL("w"), Nan::New(w));
+		ret->Set(NANX_SYMBOL("h"), Nan::New(h));
+	}
+	info.GetReturnValue().Set(Nan::New(err));
+}
+
+// TTF_OpenDocument(font, text, fg, wrapLength, tileHeight, tileCache)
+NANX_EXPORT(TTF_OpenDocument)
+{
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
+	v8::Local<v8::Object> font_object = v8::Local<v8::Object>::Cast(info[0]);
+	v8::Local<v8::String> text = v8::Local<v8::String>::Cast(info[1]);
+	SDL_Color fg = _get_color(info[2]);
+	int wrap_length = NANX_int(info[3]);
+	int tile_height = NANX_int(info[4]);
+	int tile_cache = NANX_int(info[5]);
+	TextDocument* document = new TextDocument(font_object, font, text, fg, wrap_length, tile_height, tile_cache);
+	info.GetReturnValue().Set(WrapTextDocument::NewInstance(document));
+	document->Release(); // handle holds reference
+}
+
+NANX_EXPORT(TTF_CloseDocument)
+{
+	TextDocument* document = WrapTextDocument::Peek(info[0]); if (!document) { return Nan::ThrowError("null object"); }
+	document->Close();
+}
+
+NANX_EXPORT(TTF_SizeDocument)
+{
+	TextDocument* document = WrapTextDocument::Peek(info[0]); if (!document || !document->IsOpen()) { return Nan::ThrowError("null object"); }
+	if (info[1]->IsObject())
+	{
+		v8::Local<v8::Object> ret = v8::Local<v8::Object>::Cast(info[1]);
+		ret->Set(NANX_SYMBOL("w"), Nan::New(document->m_width));
+		ret->Set(NANX_SYMBOL("h"), Nan::New(document->GetHeight()));
+		ret->Set(NANX_SYMBOL("lines"), Nan::New(document->m_line_count));
+		ret->Set(NANX_SYMBOL("tileHeight"), Nan::New(document->m_tile_height));
+		ret->Set(NANX_SYMBOL("tiles"), Nan::New(document->GetTileCount()));
+	}
+	info.GetReturnValue().Set(Nan::New(document->GetHeight()));
+}
+
+// surfaces are owned by the document cache and freed on eviction or close
+NANX_EXPORT(TTF_RenderDocumentTile)
+{
+	TextDocument* document = WrapTextDocument::Peek(info[0]); if (!document || !document->IsOpen()) { return Nan::ThrowError("null object"); }
+	int index = NANX_int(info[1]);
+	v8::Local<v8::Object> cached = document->Find(index);
+	if (!cached.IsEmpty()) { return info.GetReturnValue().Set(cached); }
+	WrapFont::Locker lock(document->GetFont()); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
+	info.GetReturnValue().Set(document->Insert(index, document->Render(font, index)));
+}
+
+NANX_EXPORT(TTF_RenderDocumentTileAsync)
+{
+	TextDocument* document = WrapTextDocument::Peek(info[0]); if (!document || !document->IsOpen()) { return Nan::ThrowError("null object"); }
+	int index = NANX_int(info[1]);
+	v8::Local<v8::Function> callback = v8::Local<v8::Function>::Cast(info[2]);
+	v8::Local<v8::Object> cached = document->Find(index);
+	if (!cached.IsEmpty())
+	{
+		// cached tiles are handed back without scheduling any work
+		v8::Local<v8::Value> argv[] = { cached };
+		Nan::MakeCallback(Nan::GetCurrentContext()->Global(), callback, countof(argv), argv);
+		return info.GetReturnValue().Set(Nan::New(0));
+	}
+	if (document->IsRendering(index))
+	{
+		// join the render already in flight
+		document->Wait(index, callback);
+		return info.GetReturnValue().Set(Nan::New(0));
+	}
+	Task_TTF_RenderDocumentTile* task = new Task_TTF_RenderDocumentTile(document, index);
+	if (!task->m_font.Acquire()) { delete task; return Nan::ThrowError("null object"); }
+	int err = Nanx::SimpleTask::Run(task);
+	if (err == 0) { document->Wait(index, callback); }
+	info.GetReturnValue().Set(Nan::New(err));
+}
+
+NANX_EXPORT(TTF_CreateRenderQueue)
+{
+	RenderQueue* queue = new RenderQueue(NANX_int(info[0]));
+	info.GetReturnValue().Set(WrapRenderQueue::NewInstance(queue));
+	queue->Release(); // handle holds reference
+}
+
+// TTF_QueueRender(queue, key, paint, text, priority)
+NANX_EXPORT(TTF_QueueRender)
+{
+	RenderQueue* queue = WrapRenderQueue::Peek(info[0]); if (!queue || queue->IsClosed()) { return Nan::ThrowError("null object"); }
+	v8::Local<v8::String> key = v8::Local<v8::String>::Cast(info[1]);
+	WrapPaint* paint = WrapPaint::Unwrap(info[2]); if (!paint || !paint->m_font_wrap->Peek()) { return Nan::ThrowError("null object"); }
+	v8::Local<v8::String> text = v8::Local<v8::String>::Cast(info[3]);
+	int priority = NANX_int(info[4]);
+	queue->Push(new RenderJob(key, paint, text, priority));
+}
+
+NANX_EXPORT(TTF_CloseRenderQueue)
+{
+	RenderQueue* queue = WrapRenderQueue::Peek(info[0]); if (!queue || queue->IsClosed()) { return Nan::ThrowError("null object"); }
+	queue->Close();
+}
+
+NANX_EXPORT(TTF_CancelRender)
+{
+	RenderQueue* queue = WrapRenderQueue::Peek(info[0]); if (!queue || queue->IsClosed()) { return Nan::ThrowError("null object"); }
+	v8::Local<v8::String> key = v8::Local<v8::String>::Cast(info[1]);
+	int count = queue->Cancel(*v8::String::Utf8Value(key));
+	info.GetReturnValue().Set(Nan::New(count));
+}
+
+// TTF_DeliverRenders(queue, budgetMs, budgetBytes, callback(key, surface, latency, error))
+// a failed render delivers a null surface and the TTF_GetError text from the worker
+// delivers at least one completed job, then stops once either budget (if > 0) is spent
+NANX_EXPORT(TTF_DeliverRenders)
+{
+	RenderQueue* queue = WrapRenderQueue::Peek(info[0]); if (!queue || queue->IsClosed()) { return Nan::ThrowError("null object"); }
+	double budget_ms = Nan::To<double>(info[1]).FromMaybe(0);
+	double budget_bytes = Nan::To<double>(info[2]).FromMaybe(0);
+	v8::Local<v8::Function> callback = v8::Local<v8::Function>::Cast(info[3]);
+	::Uint64 start = SDL_GetPerformanceCounter();
+	double bytes = 0;
+	int count = 0;
+	while (count == 0 || ((budget_ms <= 0 || _elapsed_ms(start) < budget_ms) && (budget_bytes <= 0 || bytes < budget_bytes)))
+	{
+		RenderJob* job = queue->PopCompleted(); if (!job) { break; }
+		double size = (job->m_surface)?((double) job->m_surface->pitch * job->m_surface->h):(0);
+		if (count > 0 && budget_bytes > 0 && bytes + size > budget_bytes) { queue->PushCompleted(job); break; }
+		double latency = _elapsed_ms(job->m_queued);
+		++queue->m_delivered_count;
+		queue->m_latency_total += latency;
+		queue->m_latency_last = latency;
+		if (latency > queue->m_latency_max) { queue->m_latency_max = latency; }
+		bytes += size;
+		++count;
+		Nan::HandleScope scope;
+		v8::Local<v8::Value> surface = Nan::Null();
+		if (job->m_surface) { surface = node_sdl2::WrapSurface::Hold(job->m_surface); }
+		v8::Local<v8::Value> error = Nan::Null();
+		if (job->m_error) { error = NANX_STRING(job->m_error); }
+		v8::Local<v8::Value> argv[] = { NANX_STRING(job->m_key), surface, Nan::New(latency), error };
+		job->m_surface = NULL; // script owns pointer
+		delete job;
+		Nan::MakeCallback(Nan::GetCurrentContext()->Global(), callback, countof(argv), argv);
+	}
+	info.GetReturnValue().Set(Nan::New(count));
+}
+
+NANX_EXPORT(TTF_RenderQueueStats)
+{
+	RenderQueue* queue = WrapRenderQueue::Peek(info[0]); if (!queue) { return Nan::ThrowError("null object"); }
+	if (info[1]->IsObject())
+	{
+		v8::Local<v8::Object> ret = v8::Local<v8::Object>::Cast(info[1]);
+		ret->Set(NANX_SYMBOL("pending"), Nan::New(queue->m_pending_count));
+		ret->Set(NANX_SYMBOL("running"), Nan::New(queue->m_running_count));
+		ret->Set(NANX_SYMBOL("completed"), Nan::New(queue->m_completed_count));
+		ret->Set(NANX_SYMBOL("delivered"), Nan::New(queue->m_delivered_count));
+		ret->Set(NANX_SYMBOL("latencyAvg"), Nan::New((queue->m_delivered_count > 0)?(queue->m_latency_total / (double) queue->m_delivered_count):(0.0)));
+		ret->Set(NANX_SYMBOL("latencyMax"), Nan::New(queue->m_latency_max));
+		ret->Set(NANX_SYMBOL("latencyLast"), Nan::New(queue->m_latency_last));
+	}
+	info.GetReturnValue().Set(Nan::New(queue->m_pending_count + queue->m_running_count + queue->m_completed_count));
+}
+
 NANX_EXPORT(TTF_GetFontKerningSize)
 {
-	TTF_Font* font = WrapFont::Peek(info[0]); if (!font) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
 	int prev_index = NANX_int(info[1]);
 	int index = NANX_int(info[2]);
 	int size = TTF_GetFontKerningSize(font, prev_index, index);
@@ -541,7 +1785,7 @@ NANX_EXPORT(TTF_GetFontKerningSize)
 #if SDL_TTF_VERSION_ATLEAST(2, 0, 14)
 NANX_EXPORT(TTF_GetFontKerningSizeGlyphs)
 {
-	TTF_Font* font = WrapFont::Peek(info[0]); if (!font) { return Nan::ThrowError("null object"); }
+	WrapFont::Locker lock(info[0]); TTF_Font* font = lock.Peek(); if (!font) { return Nan::ThrowError("null object"); }
 	Uint16 prev_index = NANX_Uint16(info[1]);
 	Uint16 index = NANX_Uint16(info[2]);
 	int size = TTF_GetFontKerningSizeGlyphs(font, prev_index, index);
@@ -551,6 +1795,8 @@ NANX_EXPORT(TTF_GetFontKerningSizeGlyphs)
 
 NAN_MODULE_INIT(init)
 {
+	WrapFont::LibraryMutex();
+
 	// SDL_ttf.h
 
 	NANX_CONSTANT(target, SDL_TTF_MAJOR_VERSION);
@@ -571,6 +1817,11 @@ NAN_MODULE_INIT(init)
 	NANX_CONSTANT(target, TTF_HINTING_MONO);
 	NANX_CONSTANT(target, TTF_HINTING_NONE);
 
+	NANX_CONSTANT(target, TTF_PAINT_SOLID);
+	NANX_CONSTANT(target, TTF_PAINT_SHADED);
+	NANX_CONSTANT(target, TTF_PAINT_BLENDED);
+	NANX_CONSTANT(target, TTF_PAINT_BLENDED_WRAPPED);
+
 	NANX_EXPORT_APPLY(target, TTF_LinkedVersion);
 	NANX_EXPORT_APPLY(target, TTF_ByteSwappedUNICODE);
 	NANX_EXPORT_APPLY(target, TTF_Init);
@@ -580,6 +1831,8 @@ NAN_MODULE_INIT(init)
 	NANX_EXPORT_APPLY(target, TTF_ClearError);
 	NANX_EXPORT_APPLY(target, TTF_OpenFont);
 	NANX_EXPORT_APPLY(target, TTF_OpenFontIndex);
+	NANX_EXPORT_APPLY(target, TTF_PreloadFontsTask);
+	NANX_EXPORT_APPLY(target, TTF_AbortPreload);
 	NANX_EXPORT_APPLY(target, TTF_OpenFontRW);
 	NANX_EXPORT_APPLY(target, TTF_OpenFontIndexRW);
 	NANX_EXPORT_APPLY(target, TTF_CloseFont);
@@ -622,6 +1875,21 @@ NAN_MODULE_INIT(init)
 	NANX_EXPORT_APPLY(target, TTF_RenderText);
 	NANX_EXPORT_APPLY(target, TTF_RenderUTF8);
 	NANX_EXPORT_APPLY(target, TTF_RenderUNICODE);
+	NANX_EXPORT_APPLY(target, TTF_CreatePaint);
+	NANX_EXPORT_APPLY(target, TTF_SetPaint);
+	NANX_EXPORT_APPLY(target, TTF_RenderPaint);
+	NANX_EXPORT_APPLY(target, TTF_SizePaint);
+	NANX_EXPORT_APPLY(target, TTF_OpenDocument);
+	NANX_EXPORT_APPLY(target, TTF_CloseDocument);
+	NANX_EXPORT_APPLY(target, TTF_SizeDocument);
+	NANX_EXPORT_APPLY(target, TTF_RenderDocumentTile);
+	NANX_EXPORT_APPLY(target, TTF_RenderDocumentTileAsync);
+	NANX_EXPORT_APPLY(target, TTF_CreateRenderQueue);
+	NANX_EXPORT_APPLY(target, TTF_QueueRender);
+	NANX_EXPORT_APPLY(target, TTF_CloseRenderQueue);
+	NANX_EXPORT_APPLY(target, TTF_CancelRender);
+	NANX_EXPORT_APPLY(target, TTF_DeliverRenders);
+	NANX_EXPORT_APPLY(target, TTF_RenderQueueStats);
 	NANX_EXPORT_APPLY(target, TTF_GetFontKerningSize);
 	#if SDL_TTF_VERSION_ATLEAST(2, 0, 14)
 	NANX_EXPORT_APPLY(target, TTF_GetFontKerningSizeGlyphs);
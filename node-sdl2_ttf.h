@@ -36,36 +36,110 @@
 
 namespace node_sdl2_ttf {
 
+// font file bytes shared by fonts opened from memory
+
+class FontData
+{
+private:
+	SDL_atomic_t m_refs;
+	void* m_data;
+	size_t m_size;
+private:
+	FontData(void* data, size_t size) : m_data(data), m_size(size) { SDL_AtomicSet(&m_refs, 1); }
+	~FontData() { SDL_free(m_data); m_data = NULL; m_size = 0; }
+public:
+	const void* Peek() const { return m_data; }
+	size_t Size() const { return m_size; }
+	FontData* Hold() { SDL_AtomicIncRef(&m_refs); return this; }
+	void Release() { if (SDL_AtomicDecRef(&m_refs)) { delete this; } }
+public:
+	// reads the whole file, sets the SDL error and returns NULL on failure
+	static FontData* Load(const char* file)
+	{
+		SDL_RWops* rw = SDL_RWFromFile(file, "rb"); if (!rw) { return NULL; }
+		Sint64 size = SDL_RWsize(rw);
+		if (size <= 0) { SDL_RWclose(rw); SDL_SetError("Couldn't get size of %s", file); return NULL; }
+		void* data = SDL_malloc((size_t) size);
+		if (!data) { SDL_RWclose(rw); SDL_OutOfMemory(); return NULL; }
+		size_t read = SDL_RWread(rw, data, 1, (size_t) size);
+		SDL_RWclose(rw);
+		if (read != (size_t) size) { SDL_free(data); SDL_SetError("Couldn't read %s", file); return NULL; }
+		return new FontData(data, (size_t) size);
+	}
+};
+
 // wrap TTF_Font pointer
 
 class WrapFont : public Nan::ObjectWrap
 {
 private:
 	TTF_Font* m_font;
+	FontData* m_data; // backing bytes when opened from memory
+	SDL_mutex* m_mutex; // held by anyone using m_font, main thread or worker
+	int m_users; // main thread only, workers pinning the font open
+	TTF_Font* m_closed_font; // closed by script while pinned, freed by the last Release
 public:
-	WrapFont(TTF_Font* font) : m_font(font) {}
-	~WrapFont() { Free(m_font); m_font = NULL; }
+	WrapFont(TTF_Font* font, FontData* data = NULL) : m_font(font), m_data(data), m_mutex(SDL_CreateMutex()), m_users(0), m_closed_font(NULL) {}
+	~WrapFont()
+	{
+		Free(m_font); m_font = NULL;
+		Free(m_closed_font); m_closed_font = NULL;
+		SDL_DestroyMutex(m_mutex); m_mutex = NULL;
+		ReleaseData();
+	}
 public:
 	TTF_Font* Peek() { return m_font; }
 	TTF_Font* Drop() { TTF_Font* font = m_font; m_font = NULL; return font; }
+	// close now, or once the last worker releases the font
+	void Close() { TTF_Font* font = Drop(); if (m_users > 0) { m_closed_font = font; } else { Free(font); ReleaseData(); } }
+	// main thread: keep the font open for a worker, NULL if already closed
+	TTF_Font* Acquire() { if (m_font) { ++m_users; } return m_font; }
+	void Release() { if (--m_users == 0 && m_closed_font) { Free(m_closed_font); m_closed_font = NULL; ReleaseData(); } }
+	// TTF_Font is not thread safe; every render or state change holds this
+	void Lock() { SDL_LockMutex(m_mutex); }
+	void Unlock() { SDL_UnlockMutex(m_mutex); }
+private:
+	// the file bytes are only needed while the face is open
+	void ReleaseData() { if (m_data) { m_data->Release(); m_data = NULL; } }
+public:
+	// holds the font lock for a scope on the main thread
+	class Locker
+	{
+	private:
+		WrapFont* m_wrap;
+	public:
+		Locker(v8::Local<v8::Value> value) : m_wrap(Unwrap(value)) { if (m_wrap) { m_wrap->Lock(); } }
+		Locker(WrapFont* wrap) : m_wrap(wrap) { if (m_wrap) { m_wrap->Lock(); } }
+		~Locker() { if (m_wrap) { m_wrap->Unlock(); } }
+		TTF_Font* Peek() { return (m_wrap)?(m_wrap->Peek()):(NULL); }
+	};
 public:
 	static WrapFont* Unwrap(v8::Local<v8::Value> value) { return (value->IsObject())?(Unwrap(v8::Local<v8::Object>::Cast(value))):(NULL); }
 	static WrapFont* Unwrap(v8::Local<v8::Object> object) { return Nan::ObjectWrap::Unwrap<WrapFont>(object); }
 	static TTF_Font* Peek(v8::Local<v8::Value> value) { WrapFont* wrap = Unwrap(value); return (wrap)?(wrap->Peek()):(NULL); }
 public:
 	static v8::Local<v8::Value> Hold(TTF_Font* font) { return NewInstance(font); }
+	static v8::Local<v8::Value> Hold(TTF_Font* font, FontData* data) { return NewInstance(font, data); } // takes a data reference
 	static TTF_Font* Drop(v8::Local<v8::Value> value) { WrapFont* wrap = Unwrap(value); return (wrap)?(wrap->Drop()):(NULL); }
 	static void Free(TTF_Font* font)
 	{
-		if (font) { TTF_CloseFont(font); font = NULL; }
+		if (font) { SDL_LockMutex(LibraryMutex()); TTF_CloseFont(font); SDL_UnlockMutex(LibraryMutex()); font = NULL; }
+	}
+	// FreeType's library is shared by every font, so opening and closing faces must not overlap;
+	// first called from module init so creation never races a worker
+	static SDL_mutex* LibraryMutex()
+	{
+		static SDL_mutex* g_library_mutex = NULL;
+		if (!g_library_mutex) { g_library_mutex = SDL_CreateMutex(); }
+		return g_library_mutex;
 	}
 public:
-	static v8::Local<v8::Object> NewInstance(TTF_Font* font)
+	static v8::Local<v8::Object> NewInstance(TTF_Font* font, FontData* data = NULL)
 	{
 		Nan::EscapableHandleScope scope;
 		v8::Local<v8::ObjectTemplate> object_template = GetObjectTemplate();
 		v8::Local<v8::Object> instance = object_template->NewInstance();
-		WrapFont* wrap = new WrapFont(font);
+		WrapFont* wrap = new WrapFont(font, data);
 		wrap->Wrap(instance);
 		return scope.Escape(instance);
 	}
@@ -85,6 +159,42 @@ private:
 	}
 };
 
+// a script font used by a worker: Reset/Acquire/Release on the main thread, Lock/Unlock around worker use
+
+class WrapFontUse
+{
+private:
+	Nan::Persistent<v8::Object> m_object; // keeps the wrap alive
+	WrapFont* m_wrap; // set while acquired
+	TTF_Font* m_font;
+public:
+	WrapFontUse() : m_wrap(NULL), m_font(NULL) {}
+	~WrapFontUse() { Release(); m_object.Reset(); }
+public:
+	void Reset(v8::Local<v8::Object> object) { Release(); m_object.Reset(object); }
+	TTF_Font* Peek() { return m_font; }
+	// the script font right now, NULL if closed
+	TTF_Font* Current()
+	{
+		if (m_object.IsEmpty()) { return NULL; }
+		Nan::HandleScope scope;
+		return WrapFont::Peek(Nan::New<v8::Object>(m_object));
+	}
+	TTF_Font* Acquire()
+	{
+		Release();
+		if (m_object.IsEmpty()) { return NULL; }
+		Nan::HandleScope scope;
+		WrapFont* wrap = WrapFont::Unwrap(Nan::New<v8::Object>(m_object));
+		m_font = (wrap)?(wrap->Acquire()):(NULL);
+		if (m_font) { m_wrap = wrap; }
+		return m_font;
+	}
+	void Release() { if (m_wrap) { m_wrap->Release(); m_wrap = NULL; } m_font = NULL; }
+	void Lock() { m_wrap->Lock(); }
+	void Unlock() { m_wrap->Unlock(); }
+};
+
 NAN_MODULE_INIT(init);
 
 } // namespace node_sdl2_ttf
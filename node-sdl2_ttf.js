@@ -47,6 +47,72 @@ node_sdl2_ttf.TTF_CheckError = node_sdl2_ttf.TTF_CheckError || function() {
   return error;
 };
 
+/// var preload = node_sdl2_ttf.TTF_PreloadFonts([ { file: "a.ttf", ptsize: 12 }, { file: "a.ttf", ptsize: 24 } ], {
+///   onprogress: function(result, done, total) {}, // result: { file, ptsize, index, font, error, time, wait, aborted }, times in ms
+///   signal: abort_controller.signal // optional
+/// });
+/// preload.then(function(results) { ... }); preload.abort();
+/// Entries open concurrently on the threadpool; each distinct file is read once.
+/// An aborted preload rejects with an AbortError whose results hold any fonts already delivered.
+node_sdl2_ttf.TTF_PreloadFonts = node_sdl2_ttf.TTF_PreloadFonts || function(manifest, options) {
+  options = options || {};
+  var handle = null;
+  var settled = false;
+  var signal = options.signal || null;
+  var abort = function() {
+    node_sdl2_ttf.TTF_AbortPreload(handle);
+  };
+  var detach = function() {
+    settled = true;
+    if (signal) {
+      signal.removeEventListener("abort", abort);
+    }
+  };
+  var promise = new Promise(function(resolve, reject) {
+    handle = node_sdl2_ttf.TTF_PreloadFontsTask(manifest, options.onprogress || null, function(results, aborted) {
+      detach();
+      if (aborted) {
+        var error = new Error("TTF_PreloadFonts aborted");
+        error.name = "AbortError";
+        error.results = results;
+        reject(error);
+      } else {
+        resolve(results);
+      }
+    });
+  });
+  promise.abort = abort;
+  if (signal && !settled) {
+    if (signal.aborted) {
+      abort();
+    } else {
+      signal.addEventListener("abort", abort, { once: true });
+    }
+  }
+  return promise;
+};
+
+/// var paint = node_sdl2_ttf.TTF_CreatePaint(font, { mode: node_sdl2_ttf.TTF_PAINT_BLENDED, fg: 0xFFFFFFFF, bg: 0, wrapLength: 0, format: 0 });
+/// var surface = node_sdl2_ttf.TTF_RenderPaint(paint, "label"); node_sdl2_ttf.TTF_SizePaint(paint, "label", size);
+/// Colors and options are decoded once by TTF_CreatePaint/TTF_SetPaint instead of on every render call.
+/// TTF_SizePaint follows the paint mode; TTF_PAINT_BLENDED_WRAPPED reports the wrapped block size.
+
+/// var queue = node_sdl2_ttf.TTF_CreateRenderQueue(workers);
+/// node_sdl2_ttf.TTF_QueueRender(queue, "score", paint, "Score: 100", priority); // replaces a pending "score" job
+/// node_sdl2_ttf.TTF_CancelRender(queue, "score");
+/// // once per frame, spend at most 2 ms and 1 MB handing surfaces over (0 for no limit)
+/// node_sdl2_ttf.TTF_DeliverRenders(queue, 2, 1 << 20, function(key, surface, latency, error) {}); // surface null on error
+/// var stats = {}; node_sdl2_ttf.TTF_RenderQueueStats(queue, stats); // { pending, running, completed, delivered, latencyAvg, latencyMax, latencyLast }
+/// node_sdl2_ttf.TTF_CloseRenderQueue(queue); // drops queued and undelivered jobs, also done when the queue is collected
+
+/// var doc = node_sdl2_ttf.TTF_OpenDocument(font, text, fg, wrapLength, tileHeight, tileCache);
+/// var size = {}; node_sdl2_ttf.TTF_SizeDocument(doc, size); // { w, h, lines, tileHeight, tiles }
+/// var tile = node_sdl2_ttf.TTF_RenderDocumentTile(doc, Math.floor(scrollY / size.tileHeight));
+/// node_sdl2_ttf.TTF_RenderDocumentTileAsync(doc, index, function(tile) {}); // called at once for a cached tile;
+///   requests for a tile already rendering share that render
+/// Tiles are cached per document (least recently used, tileCache entries) and freed when
+/// evicted or on TTF_CloseDocument, so copy or upload a tile before rendering more.
+
 /// var node_sdl2_ttf = require('@flyover/node-sdl2_ttf');
 /// var sdl_ttf = node_sdl2_ttf.TTF();
 /// node_sdl2_ttf.TTF_* -> sdl_ttf.*